@@ -0,0 +1,124 @@
+/* Measure per-transaction latency for each system clock and power saving
+ * setting, so adapters can be pinned to the fastest setup.
+ *
+ * Usage: bench_clock [hidpath] [i2caddr] [iterations] [idle_ms]
+ *   i2caddr:    if non-zero, also time a 1-byte write to this slave
+ *   idle_ms:    if non-zero, sleep this long before each run and report the
+ *               latency of the first transaction after the idle period
+ */
+
+#include <time.h>
+#include "mgos.h"
+#include "ft260.h"
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static bool bench_one(struct ft260_dev *d, uint16_t addr) {
+  uint8_t status;
+  uint8_t byte = 0;
+
+  if (addr) {
+    return ft260_i2c_write(d, addr, &byte, 1, true /* stop */);
+  }
+  return ft260_i2c_get_status(d, &status);
+}
+
+static void bench_run(struct ft260_dev *d, uint16_t addr, int iterations, int idle_ms, uint64_t *samples) {
+  uint64_t start, total = 0, first = 0;
+  int      ok = 0;
+
+  if (idle_ms > 0) {
+    usleep(idle_ms * 1000);
+    start = now_ns();
+    bench_one(d, addr);
+    first = now_ns() - start;
+  }
+  for (int i = 0; i < iterations; i++) {
+    start = now_ns();
+    if (bench_one(d, addr)) {
+      samples[ok++] = now_ns() - start;
+    }
+  }
+  if (ok == 0) {
+    printf("no successful transactions\r\n");
+    return;
+  }
+  qsort(samples, ok, sizeof(*samples), cmp_u64);
+  for (int i = 0; i < ok; i++) {
+    total += samples[i];
+  }
+  printf("min=%7.1fus avg=%7.1fus p50=%7.1fus p99=%7.1fus max=%7.1fus",
+         samples[0] / 1e3, total / (double)ok / 1e3, samples[ok / 2] / 1e3,
+         samples[(ok * 99) / 100] / 1e3, samples[ok - 1] / 1e3);
+  if (idle_ms > 0) {
+    printf(" after_idle=%7.1fus", first / 1e3);
+  }
+  printf(" (%d/%d ok)\r\n", ok, iterations);
+}
+
+int main(int argc, char **argv) {
+  const char *      hidpath    = NULL;
+  uint16_t          addr       = 0;
+  int               iterations = 1000;
+  int               idle_ms    = 0;
+  struct ft260_dev *d;
+  enum ft260_clock  orig_clock;
+  bool              orig_power_saving;
+  uint64_t *        samples;
+  static const char *clock_str[] = { "12MHz", "24MHz", "48MHz" };
+
+  if (argc > 1 && argv[1][0]) {
+    hidpath = argv[1];
+  }
+  if (argc > 2) {
+    addr = (uint16_t)strtol(argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    iterations = atoi(argv[3]);
+  }
+  if (argc > 4) {
+    idle_ms = atoi(argv[4]);
+  }
+  if (iterations <= 0 || !(samples = calloc(iterations, sizeof(*samples)))) {
+    LOG(LL_ERROR, ("Invalid iteration count"));
+    return -1;
+  }
+
+  if (!(d = ft260_i2c_create(hidpath))) {
+    LOG(LL_ERROR, ("Could not create FT260 driver"));
+    return -1;
+  }
+  if (!ft260_get_clock(d, &orig_clock) || !ft260_get_power_saving(d, &orig_power_saving)) {
+    LOG(LL_ERROR, ("Could not read system settings"));
+    return -1;
+  }
+
+  printf("Timing %d %s per setting\r\n", iterations, addr ? "1-byte I2C writes" : "status reads");
+  for (int clock = FT260_CLOCK_12MHZ; clock <= FT260_CLOCK_48MHZ; clock++) {
+    for (int ps = 0; ps <= 1; ps++) {
+      if (!ft260_set_clock(d, (enum ft260_clock)clock) || !ft260_set_power_saving(d, ps)) {
+        LOG(LL_ERROR, ("Could not apply clock=%s power_saving=%d", clock_str[clock], ps));
+        continue;
+      }
+      printf("clock=%-5s power_saving=%-3s: ", clock_str[clock], ps ? "on" : "off");
+      bench_run(d, addr, iterations, idle_ms, samples);
+    }
+  }
+
+  ft260_set_clock(d, orig_clock);
+  ft260_set_power_saving(d, orig_power_saving);
+  free(samples);
+  ft260_i2c_destroy(&d);
+  return 0;
+}
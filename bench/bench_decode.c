@@ -0,0 +1,115 @@
+/* Microbenchmark of the sample decoders used by ft260_i2c_read_reg_u{16,24,32}(),
+ * against the byte-shifting loop ft260_i2c_read_reg_w() uses. Does not need
+ * an FT260.
+ *
+ * Usage: bench_decode [samples] [rounds]
+ */
+
+#include <time.h>
+#include "mgos.h"
+#include "ft260.h"
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t naive_sample(const uint8_t *p, int width, enum ft260_endian endian) {
+  uint32_t v = 0;
+
+  for (int b = 0; b < width; b++) {
+    v = (v << 8) | p[endian == FT260_BIG_ENDIAN ? b : width - 1 - b];
+  }
+  return v;
+}
+
+// Reference decoder, also used to check the results.
+static void naive_decode(const uint8_t *src, size_t count, int width, enum ft260_endian endian, uint32_t *dst) {
+  for (size_t i = 0; i < count; i++) {
+    dst[i] = naive_sample(src + i * width, width, endian);
+  }
+}
+
+static void decode(const uint8_t *src, size_t count, int width, enum ft260_endian endian, void *dst) {
+  switch (width) {
+  case 2: ft260_decode_u16(src, count, endian, dst); break;
+
+  case 3: ft260_decode_u24(src, count, endian, dst); break;
+
+  default: ft260_decode_u32(src, count, endian, dst); break;
+  }
+}
+
+static bool check(const void *got, const uint32_t *want, size_t count, int width) {
+  for (size_t i = 0; i < count; i++) {
+    uint32_t v = (width == 2) ? ((const uint16_t *)got)[i] : ((const uint32_t *)got)[i];
+    if (v != want[i]) {
+      LOG(LL_ERROR, ("Mismatch at sample %zu: got 0x%08x, want 0x%08x", i, v, want[i]));
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  size_t    count  = 4096;
+  int       rounds = 2000;
+  uint8_t * raw;
+  uint32_t *want, *got;
+  bool      ok = true;
+
+  if (argc > 1) {
+    count = strtoul(argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    rounds = atoi(argv[2]);
+  }
+  raw  = malloc(count * 4);
+  want = malloc(count * 4);
+  got  = malloc(count * 4);
+  if (!raw || !want || !got || rounds <= 0) {
+    return -1;
+  }
+  srand(260);
+  for (size_t i = 0; i < count * 4; i++) {
+    raw[i] = (uint8_t)rand();
+  }
+
+  printf("Decoding %zu samples, %d rounds\r\n", count, rounds);
+  for (int width = 2; width <= 4; width++) {
+    for (int e = FT260_BIG_ENDIAN; e <= FT260_LITTLE_ENDIAN; e++) {
+      enum ft260_endian endian = (enum ft260_endian)e;
+      uint64_t          start, t_naive, t_fast;
+
+      start = now_ns();
+      for (int r = 0; r < rounds; r++) {
+        naive_decode(raw, count, width, endian, want);
+      }
+      t_naive = now_ns() - start;
+
+      start = now_ns();
+      for (int r = 0; r < rounds; r++) {
+        decode(raw, count, width, endian, got);
+      }
+      t_fast = now_ns() - start;
+      ok &= check(got, want, count, width);
+
+      // In place, the way the read helpers use it.
+      memcpy((width == 3) ? (uint8_t *)got + count : (uint8_t *)got, raw, count * width);
+      decode((width == 3) ? (uint8_t *)got + count : (uint8_t *)got, count, width, endian, got);
+      ok &= check(got, want, count, width);
+
+      printf("u%d %s: naive %6.2f ns/sample, decode %6.2f ns/sample (%.1fx)\r\n",
+             width * 8, endian == FT260_BIG_ENDIAN ? "BE" : "LE",
+             t_naive / (double)rounds / count, t_fast / (double)rounds / count,
+             t_fast ? (double)t_naive / t_fast : 0.0);
+    }
+  }
+
+  free(raw);
+  free(want);
+  free(got);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/* Compare effective bus utilization of polling a data-ready status register
+ * against waiting for the sensor's interrupt line on the FT260 INTRIN pin.
+ * Wire the sensor's data-ready output to GPIO3 (INTRIN).
+ *
+ * Usage: bench_int hidpath addr status_reg ready_mask data_reg data_len [seconds]
+ *   hidpath may be "" to autodetect.
+ */
+
+#include <time.h>
+#include "mgos.h"
+#include "ft260.h"
+
+#define BENCH_INT_MAX_DATA    (64) // Largest sample read per interrupt
+
+struct bench_int_ctx {
+  uint16_t addr;
+  uint8_t  status_reg;
+  uint8_t  ready_mask;
+  uint8_t  data_reg;
+  size_t   data_len;
+  uint32_t transactions; // I2C register reads issued
+  uint32_t samples;      // Reads that returned new data
+  uint32_t errors;
+};
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void read_sample(struct ft260_dev *d, struct bench_int_ctx *c) {
+  uint8_t buf[BENCH_INT_MAX_DATA];
+
+  c->transactions++;
+  if (ft260_i2c_read_reg_n(d, c->addr, c->data_reg, c->data_len, buf)) {
+    c->samples++;
+  } else {
+    c->errors++;
+  }
+}
+
+static void on_interrupt(struct ft260_dev *d, void *arg) {
+  read_sample(d, (struct bench_int_ctx *)arg);
+}
+
+static void report(const char *mode, const struct bench_int_ctx *c, uint64_t elapsed_ms) {
+  printf("%-9s: %6u transactions, %6u samples, %3u errors, %7.1f samples/s, utilization %5.1f%%\r\n",
+         mode, c->transactions, c->samples, c->errors,
+         elapsed_ms ? c->samples * 1000.0 / elapsed_ms : 0.0,
+         c->transactions ? 100.0 * c->samples / c->transactions : 0.0);
+}
+
+int main(int argc, char **argv) {
+  struct ft260_dev *   d;
+  struct bench_int_ctx poll_ctx, int_ctx;
+  uint64_t             start, elapsed;
+  int                  seconds = 10;
+  uint8_t              status;
+
+  if (argc < 7) {
+    printf("Usage: %s hidpath addr status_reg ready_mask data_reg data_len [seconds]\r\n", argv[0]);
+    return -1;
+  }
+  memset(&poll_ctx, 0, sizeof(poll_ctx));
+  poll_ctx.addr       = (uint16_t)strtol(argv[2], NULL, 0);
+  poll_ctx.status_reg = (uint8_t)strtol(argv[3], NULL, 0);
+  poll_ctx.ready_mask = (uint8_t)strtol(argv[4], NULL, 0);
+  poll_ctx.data_reg   = (uint8_t)strtol(argv[5], NULL, 0);
+  poll_ctx.data_len   = strtoul(argv[6], NULL, 0);
+  if (argc > 7) {
+    seconds = atoi(argv[7]);
+  }
+  if (poll_ctx.data_len == 0 || poll_ctx.data_len > BENCH_INT_MAX_DATA) {
+    LOG(LL_ERROR, ("data_len must be 1..%d", BENCH_INT_MAX_DATA));
+    return -1;
+  }
+  int_ctx = poll_ctx;
+
+  if (!(d = ft260_i2c_create(argv[1][0] ? argv[1] : NULL))) {
+    LOG(LL_ERROR, ("Could not create FT260 driver"));
+    return -1;
+  }
+
+  // Polling: read the status register until data is ready, then the data.
+  start = now_ms();
+  while (now_ms() - start < (uint64_t)seconds * 1000) {
+    poll_ctx.transactions++;
+    if (!ft260_i2c_read_reg_b(d, poll_ctx.addr, poll_ctx.status_reg, &status)) {
+      poll_ctx.errors++;
+      continue;
+    }
+    if (status & poll_ctx.ready_mask) {
+      read_sample(d, &poll_ctx);
+    }
+  }
+  report("polling", &poll_ctx, now_ms() - start);
+
+  // Interrupt driven: only touch the bus when INTRIN fires.
+  if (!ft260_int_enable(d, FT260_INT_RISING, 1, on_interrupt, &int_ctx)) {
+    LOG(LL_ERROR, ("Could not enable interrupt"));
+    ft260_i2c_destroy(&d);
+    return -1;
+  }
+  start = now_ms();
+  while ((elapsed = now_ms() - start) < (uint64_t)seconds * 1000) {
+    if (ft260_int_poll(d, (int)((uint64_t)seconds * 1000 - elapsed)) < 0) {
+      break;
+    }
+  }
+  report("interrupt", &int_ctx, now_ms() - start);
+
+  ft260_int_disable(d);
+  ft260_i2c_destroy(&d);
+  return 0;
+}
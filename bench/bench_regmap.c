@@ -0,0 +1,89 @@
+/* Time register accesses through accessors generated by ft260-regmap.h
+ * against the generic ft260_i2c_{read,write}_reg_n() helpers, using a
+ * BMP280/BME280 pressure sensor.
+ *
+ * Usage: bench_regmap [hidpath] [i2caddr] [iterations]
+ */
+
+#include <time.h>
+#include "mgos.h"
+#include "ft260-regmap.h"
+
+#define BMP280_REGS(X)                                  \
+  X(bmp280_chip_id,   0xD0, 1, FT260_BIG_ENDIAN,    RO) \
+  X(bmp280_reset,     0xE0, 1, FT260_BIG_ENDIAN,    WO) \
+  X(bmp280_ctrl_meas, 0xF4, 1, FT260_BIG_ENDIAN,    RW) \
+  X(bmp280_press,     0xF7, 3, FT260_BIG_ENDIAN,    RO) \
+  X(bmp280_dig_t1,    0x88, 2, FT260_LITTLE_ENDIAN, RO)
+
+FT260_REGMAP(BMP280_REGS)
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char *what, uint64_t elapsed, int ok, int iterations) {
+  printf("%-28s: %7.1fus/op (%d/%d ok)\r\n", what, ok ? elapsed / 1e3 / ok : 0.0, ok, iterations);
+}
+
+int main(int argc, char **argv) {
+  const char *      hidpath    = NULL;
+  uint16_t          addr       = 0x76;
+  int               iterations = 1000;
+  struct ft260_dev *d;
+  uint8_t           id, ctrl, raw[3];
+  uint16_t          t1;
+  uint32_t          press;
+  uint64_t          start;
+  int               ok;
+
+  if (argc > 1 && argv[1][0]) {
+    hidpath = argv[1];
+  }
+  if (argc > 2) {
+    addr = (uint16_t)strtol(argv[2], NULL, 0);
+  }
+  if (argc > 3) {
+    iterations = atoi(argv[3]);
+  }
+
+  if (!(d = ft260_i2c_create(hidpath))) {
+    LOG(LL_ERROR, ("Could not create FT260 driver"));
+    return -1;
+  }
+  if (!bmp280_chip_id_read(d, addr, &id) || !bmp280_dig_t1_read(d, addr, &t1) || !bmp280_ctrl_meas_read(d, addr, &ctrl)) {
+    LOG(LL_ERROR, ("No BMP280 at 0x%02x", addr));
+    ft260_i2c_destroy(&d);
+    return -1;
+  }
+  LOG(LL_INFO, ("chip_id=0x%02x dig_T1=%u ctrl_meas=0x%02x", id, t1, ctrl));
+
+  start = now_ns();
+  for (ok = 0; ok < iterations && bmp280_press_read(d, addr, &press); ok++) {
+  }
+  report("bmp280_press_read", now_ns() - start, ok, iterations);
+
+  start = now_ns();
+  for (ok = 0; ok < iterations && ft260_i2c_read_reg_n(d, addr, 0xF7, sizeof(raw), raw); ok++) {
+  }
+  report("ft260_i2c_read_reg_n", now_ns() - start, ok, iterations);
+
+  start = now_ns();
+  for (ok = 0; ok < iterations && bmp280_ctrl_meas_write(d, addr, ctrl); ok++) {
+  }
+  report("bmp280_ctrl_meas_write", now_ns() - start, ok, iterations);
+
+  start = now_ns();
+  for (ok = 0; ok < iterations && ft260_i2c_write_reg_n(d, addr, 0xF4, 1, &ctrl); ok++) {
+  }
+  report("ft260_i2c_write_reg_n", now_ns() - start, ok, iterations);
+
+  if (!bmp280_reset_write(d, addr, 0xB6)) {
+    LOG(LL_ERROR, ("Could not reset BMP280"));
+  }
+  ft260_i2c_destroy(&d);
+  return 0;
+}
@@ -0,0 +1,400 @@
+/* Concurrency and soak stress harness. Runs mixed workloads from several
+ * threads against a 24Cxx EEPROM on the bus, and checks everything read back
+ * against a shadow copy. Write and read NACKs are injected by addressing a
+ * slave that is not present, and the next operation must succeed again.
+ * Read timeouts need a slave that stretches the clock, so they are not
+ * injected.
+ *
+ * Throughput and tail latency are tracked per interval. The first interval
+ * is the baseline, and the run fails when a later interval regresses past
+ * the configured limits, or on any data mismatch.
+ *
+ * The driver is not thread safe, so operations on the device are serialized
+ * with a mutex, the way an application sharing an adapter has to.
+ *
+ * Usage: stress [-d hidpath] [-a addr] [-p page_size] [-w addr_width]
+ *               [-s size] [-t threads] [-T seconds] [-i interval]
+ *               [-n absent_addr] [-f fault_pct] [-l p99_drift_pct]
+ *               [-r throughput_drop_pct]
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "mgos.h"
+#include "ft260.h"
+
+#define STRESS_MAX_THREADS    (32)
+#define STRESS_MAX_SAMPLES    (1 << 20)
+#define STRESS_MAX_PAGE       (256)
+
+enum stress_op {
+  OP_EEPROM_WRITE = 0,
+  OP_EEPROM_READ,
+  OP_REG,
+  OP_RESET,
+  OP_NACK,
+  OP_READ_NACK,
+  OP_MAX
+};
+
+static const char *stress_op_str[OP_MAX] = { "eeprom_write", "eeprom_read", "reg", "reset", "nack", "read_nack" };
+
+struct stress_config {
+  const char *hidpath;
+  uint16_t    absent_addr;
+  int         threads;
+  int         seconds;
+  int         interval;
+  int         fault_pct;
+  int         p99_drift_pct;
+  int         throughput_drop_pct;
+};
+
+struct stress_thread {
+  pthread_t    thread;
+  int          id;
+  unsigned int seed;
+  uint32_t     offset; // Region of the EEPROM owned by this thread
+  uint32_t     len;
+  uint8_t *    shadow;
+};
+
+struct stress_window {
+  uint32_t ops;
+  uint32_t nsamples;
+  uint64_t samples[STRESS_MAX_SAMPLES]; // Latency in us
+};
+
+static struct ft260_dev *    s_dev;
+static struct ft260_eeprom   s_eeprom;
+static struct stress_config  s_cfg;
+static pthread_mutex_t       s_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool           s_stop;
+static struct stress_window  s_window;
+static uint32_t              s_ops[OP_MAX];
+static uint32_t              s_mismatches;
+static uint32_t              s_failures;  // Operations that should have worked but didn't
+static uint32_t              s_ghosts;    // Injected faults that unexpectedly succeeded
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+// Wait for the EEPROM write cycle after a raw register write.
+static bool stress_ack_poll(void) {
+  uint64_t start = now_us();
+
+  while (now_us() - start < 20000) {
+    if (ft260_i2c_probe(s_dev, s_eeprom.addr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool stress_compare(struct stress_thread *t, uint32_t off, const uint8_t *buf, size_t len, const char *what) {
+  for (size_t i = 0; i < len; i++) {
+    if (buf[i] != t->shadow[off + i]) {
+      LOG(LL_ERROR, ("Thread %d: %s mismatch at 0x%x: read 0x%02x, expected 0x%02x",
+                     t->id, what, t->offset + off + (uint32_t)i, buf[i], t->shadow[off + i]));
+      s_mismatches++;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Run one operation with the device lock held. Returns false on unexpected failure.
+static bool stress_op(struct stress_thread *t, enum stress_op op) {
+  uint8_t  buf[STRESS_MAX_PAGE];
+  uint32_t off, len;
+  uint8_t  value;
+
+  switch (op) {
+  case OP_EEPROM_WRITE:
+    off = rand_r(&t->seed) % t->len;
+    len = 1 + rand_r(&t->seed) % s_eeprom.page_size;
+    len = (len > t->len - off) ? t->len - off : len;
+    for (uint32_t i = 0; i < len; i++) {
+      buf[i] = (uint8_t)rand_r(&t->seed);
+    }
+    if (!ft260_eeprom_write(s_dev, &s_eeprom, t->offset + off, buf, len)) {
+      return false;
+    }
+    memcpy(t->shadow + off, buf, len);
+    return true;
+
+  case OP_EEPROM_READ:
+    off = rand_r(&t->seed) % t->len;
+    len = 1 + rand_r(&t->seed) % sizeof(buf);
+    len = (len > t->len - off) ? t->len - off : len;
+    if (!ft260_eeprom_read(s_dev, &s_eeprom, t->offset + off, buf, len)) {
+      return false;
+    }
+    return stress_compare(t, off, buf, len, "sequential read");
+
+  case OP_REG:
+    off   = rand_r(&t->seed) % t->len;
+    value = (uint8_t)rand_r(&t->seed);
+    if (!ft260_i2c_write_reg_b(s_dev, s_eeprom.addr, (uint8_t)(t->offset + off), value)) {
+      return false;
+    }
+    t->shadow[off] = value;
+    if (!stress_ack_poll()) {
+      return false;
+    }
+    if (!ft260_i2c_read_reg_b(s_dev, s_eeprom.addr, (uint8_t)(t->offset + off), &value)) {
+      return false;
+    }
+    return stress_compare(t, off, &value, 1, "register read");
+
+  case OP_RESET:
+    return ft260_i2c_reset(s_dev);
+
+  case OP_NACK:
+    buf[0] = 0;
+    if (ft260_i2c_write(s_dev, s_cfg.absent_addr, buf, 1, true /* stop */)) {
+      s_ghosts++;
+    }
+    return ft260_i2c_reset(s_dev);
+
+  case OP_READ_NACK:
+    if (ft260_i2c_read(s_dev, s_cfg.absent_addr, buf, 1, true /* stop */)) {
+      s_ghosts++;
+    }
+    return ft260_i2c_reset(s_dev);
+
+  default:
+    return false;
+  }
+}
+
+// Register helpers only fit EEPROMs with 1-byte addresses in block 0.
+static bool stress_reg_fits(const struct stress_thread *t) {
+  return s_eeprom.addr_width == 1 && t->offset + t->len <= 256;
+}
+
+static enum stress_op stress_pick(struct stress_thread *t) {
+  int r = rand_r(&t->seed) % 100;
+
+  if (r < s_cfg.fault_pct) {
+    return (r % 3 == 0) ? OP_READ_NACK : OP_NACK;
+  }
+  r = rand_r(&t->seed) % 100;
+  if (r < 35) {
+    return OP_EEPROM_WRITE;
+  }
+  if (r < 70) {
+    return OP_EEPROM_READ;
+  }
+  if (r < 95) {
+    return stress_reg_fits(t) ? OP_REG : OP_EEPROM_READ;
+  }
+  return OP_RESET;
+}
+
+static void *stress_thread_main(void *arg) {
+  struct stress_thread *t = (struct stress_thread *)arg;
+
+  while (!atomic_load(&s_stop)) {
+    enum stress_op op = stress_pick(t);
+    uint64_t       start, elapsed;
+    bool           ok;
+
+    pthread_mutex_lock(&s_lock);
+    start   = now_us();
+    ok      = stress_op(t, op);
+    elapsed = now_us() - start;
+    s_ops[op]++;
+    if (!ok) {
+      s_failures++;
+      LOG(LL_ERROR, ("Thread %d: %s failed", t->id, stress_op_str[op]));
+    }
+    // Injected faults are slow by design, keep them out of the latency figures.
+    if (op != OP_NACK && op != OP_READ_NACK) {
+      s_window.ops++;
+      if (s_window.nsamples < STRESS_MAX_SAMPLES) {
+        s_window.samples[s_window.nsamples++] = elapsed;
+      }
+    }
+    pthread_mutex_unlock(&s_lock);
+  }
+  return NULL;
+}
+
+static void stress_usage(const char *prog) {
+  printf("Usage: %s [-d hidpath] [-a addr] [-p page_size] [-w addr_width] [-s size] [-t threads] [-T seconds] [-i interval]"
+         " [-n absent_addr] [-f fault_pct] [-l p99_drift_pct] [-r throughput_drop_pct]\r\n", prog);
+}
+
+int main(int argc, char **argv) {
+  static struct stress_thread threads[STRESS_MAX_THREADS];
+  double   base_tput = 0, base_p99 = 0;
+  bool     failed    = false;
+  uint32_t region;
+  int      opt;
+
+  s_eeprom.addr             = 0x50;
+  s_eeprom.page_size        = 16;
+  s_eeprom.addr_width       = 1;
+  s_eeprom.size             = 256;
+  s_cfg.absent_addr         = 0x0f;
+  s_cfg.threads             = 4;
+  s_cfg.seconds             = 60;
+  s_cfg.interval            = 10;
+  s_cfg.fault_pct           = 10;
+  s_cfg.p99_drift_pct       = 50;
+  s_cfg.throughput_drop_pct = 30;
+
+  while ((opt = getopt(argc, argv, "d:a:p:w:s:t:T:i:n:f:l:r:h")) != -1) {
+    switch (opt) {
+    case 'd': s_cfg.hidpath = optarg; break;
+
+    case 'a': s_eeprom.addr = (uint16_t)strtol(optarg, NULL, 0); break;
+
+    case 'p': s_eeprom.page_size = (uint16_t)strtol(optarg, NULL, 0); break;
+
+    case 'w': s_eeprom.addr_width = (uint8_t)strtol(optarg, NULL, 0); break;
+
+    case 's': s_eeprom.size = strtoul(optarg, NULL, 0); break;
+
+    case 't': s_cfg.threads = atoi(optarg); break;
+
+    case 'T': s_cfg.seconds = atoi(optarg); break;
+
+    case 'i': s_cfg.interval = atoi(optarg); break;
+
+    case 'n': s_cfg.absent_addr = (uint16_t)strtol(optarg, NULL, 0); break;
+
+    case 'f': s_cfg.fault_pct = atoi(optarg); break;
+
+    case 'l': s_cfg.p99_drift_pct = atoi(optarg); break;
+
+    case 'r': s_cfg.throughput_drop_pct = atoi(optarg); break;
+
+    default: stress_usage(argv[0]); return -1;
+    }
+  }
+  if (s_cfg.threads < 1 || s_cfg.threads > STRESS_MAX_THREADS || s_cfg.interval < 1 || s_cfg.seconds < 2 * s_cfg.interval ||
+      s_eeprom.page_size == 0 || s_eeprom.page_size > STRESS_MAX_PAGE ||
+      (region = (s_eeprom.size / s_cfg.threads) / s_eeprom.page_size * s_eeprom.page_size) == 0) {
+    LOG(LL_ERROR, ("Invalid configuration: need 1..%d threads, pages of 1..%d bytes, a page per thread, and at least two intervals",
+                   STRESS_MAX_THREADS, STRESS_MAX_PAGE));
+    stress_usage(argv[0]);
+    return -1;
+  }
+
+  if (!(s_dev = ft260_i2c_create(s_cfg.hidpath))) {
+    LOG(LL_ERROR, ("Could not create FT260 driver"));
+    return -1;
+  }
+
+  // Give each thread its own region and seed it with known contents.
+  for (int i = 0; i < s_cfg.threads; i++) {
+    struct stress_thread *t = &threads[i];
+
+    t->id     = i;
+    t->seed   = 260 + i;
+    t->offset = i * region;
+    t->len    = region;
+    if (!(t->shadow = malloc(region))) {
+      return -1;
+    }
+    for (uint32_t j = 0; j < region; j++) {
+      t->shadow[j] = (uint8_t)rand_r(&t->seed);
+    }
+    if (!ft260_eeprom_write(s_dev, &s_eeprom, t->offset, t->shadow, region) ||
+        !ft260_eeprom_verify(s_dev, &s_eeprom, t->offset, t->shadow, region)) {
+      LOG(LL_ERROR, ("Could not initialize EEPROM region of thread %d", i));
+      return -1;
+    }
+  }
+
+  printf("Running %d threads for %ds, fault rate %d%%, limits: p99 +%d%%, throughput -%d%%\r\n",
+         s_cfg.threads, s_cfg.seconds, s_cfg.fault_pct, s_cfg.p99_drift_pct, s_cfg.throughput_drop_pct);
+  for (int i = 0; i < s_cfg.threads; i++) {
+    pthread_create(&threads[i].thread, NULL, stress_thread_main, &threads[i]);
+  }
+
+  for (int w = 0; w * s_cfg.interval < s_cfg.seconds && !failed; w++) {
+    uint64_t *samples;
+    uint32_t  n, ops;
+    double    tput, p50, p99, p999;
+
+    sleep(s_cfg.interval);
+    pthread_mutex_lock(&s_lock);
+    n       = s_window.nsamples;
+    ops     = s_window.ops;
+    samples = malloc((n ? n : 1) * sizeof(*samples));
+    if (samples) {
+      memcpy(samples, s_window.samples, n * sizeof(*samples));
+    }
+    s_window.nsamples = 0;
+    s_window.ops      = 0;
+    failed            = s_mismatches > 0 || s_failures > 0;
+    pthread_mutex_unlock(&s_lock);
+    if (!samples || n == 0) {
+      LOG(LL_ERROR, ("No operations completed in interval %d", w));
+      free(samples);
+      failed = true;
+      break;
+    }
+
+    qsort(samples, n, sizeof(*samples), cmp_u64);
+    tput = ops / (double)s_cfg.interval;
+    p50  = samples[n / 2] / 1e3;
+    p99  = samples[(n * 99ULL) / 100] / 1e3;
+    p999 = samples[(n * 999ULL) / 1000] / 1e3;
+    free(samples);
+    printf("interval %3d: %8.1f ops/s p50=%7.2fms p99=%7.2fms p99.9=%7.2fms mismatches=%u failures=%u\r\n",
+           w, tput, p50, p99, p999, s_mismatches, s_failures);
+
+    if (w == 0) {
+      base_tput = tput;
+      base_p99  = p99;
+      continue;
+    }
+    if (p99 > base_p99 * (100 + s_cfg.p99_drift_pct) / 100) {
+      LOG(LL_ERROR, ("p99 latency regressed: %.2fms vs baseline %.2fms", p99, base_p99));
+      failed = true;
+    }
+    if (tput < base_tput * (100 - s_cfg.throughput_drop_pct) / 100) {
+      LOG(LL_ERROR, ("Throughput regressed: %.1f ops/s vs baseline %.1f ops/s", tput, base_tput));
+      failed = true;
+    }
+  }
+
+  atomic_store(&s_stop, true);
+  for (int i = 0; i < s_cfg.threads; i++) {
+    pthread_join(threads[i].thread, NULL);
+  }
+
+  // Final integrity check of every region.
+  for (int i = 0; i < s_cfg.threads; i++) {
+    if (!ft260_eeprom_verify(s_dev, &s_eeprom, threads[i].offset, threads[i].shadow, threads[i].len)) {
+      LOG(LL_ERROR, ("Final verify of thread %d region failed", i));
+      s_mismatches++;
+    }
+    free(threads[i].shadow);
+  }
+
+  printf("ops:");
+  for (int op = 0; op < OP_MAX; op++) {
+    printf(" %s=%u", stress_op_str[op], s_ops[op]);
+  }
+  printf("\r\nmismatches=%u failures=%u ghost_acks=%u: %s\r\n", s_mismatches, s_failures, s_ghosts,
+         (failed || s_mismatches || s_failures) ? "FAIL" : "PASS");
+
+  ft260_i2c_destroy(&s_dev);
+  return (failed || s_mismatches || s_failures) ? 1 : 0;
+}
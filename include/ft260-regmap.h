@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ft260.h"
+
+/*
+ * Typed register accessors generated from a device's register map. Declare
+ * the map as a list of X(name, register, width, endian, access) entries,
+ * where width is 1 to 4 bytes and access is RO, WO or RW, and expand it once
+ * (without a trailing semicolon):
+ *
+ *   #define BMP280_REGS(X)                                \
+ *     X(bmp280_chip_id,   0xD0, 1, FT260_BIG_ENDIAN, RO)    \
+ *     X(bmp280_ctrl_meas, 0xF4, 1, FT260_BIG_ENDIAN, RW)    \
+ *     X(bmp280_press,     0xF7, 3, FT260_BIG_ENDIAN, RO)    \
+ *     X(bmp280_dig_t1,    0x88, 2, FT260_LITTLE_ENDIAN, RO)
+ *
+ *   FT260_REGMAP(BMP280_REGS)
+ *
+ * This defines static inline `bool bmp280_chip_id_read(d, addr, uint8_t *)`,
+ * `bool bmp280_ctrl_meas_write(d, addr, uint8_t)` and so on. Values are
+ * uint8_t, uint16_t or uint32_t by width. Each accessor builds its transfer
+ * in one fixed-size stack buffer, unrolls the byte order conversion at
+ * compile time and calls ft260_i2c_write()/ft260_i2c_read() directly. Writes
+ * therefore bypass write combining, after flushing anything it holds.
+ */
+
+#define FT260_REG_TYPE_1    uint8_t
+#define FT260_REG_TYPE_2    uint16_t
+#define FT260_REG_TYPE_3    uint32_t
+#define FT260_REG_TYPE_4    uint32_t
+#define FT260_REG_TYPE(width)    FT260_REG_TYPE_##width
+
+static inline uint32_t ft260_reg_decode(const uint8_t *buf, const int width, const enum ft260_endian endian) {
+  uint32_t value = 0;
+
+  for (int i = 0; i < width; i++) {
+    value = (value << 8) | buf[endian == FT260_BIG_ENDIAN ? i : width - 1 - i];
+  }
+  return value;
+}
+
+static inline void ft260_reg_encode(uint8_t *buf, uint32_t value, const int width, const enum ft260_endian endian) {
+  for (int i = 0; i < width; i++) {
+    buf[endian == FT260_BIG_ENDIAN ? width - 1 - i : i] = (uint8_t)value;
+    value >>= 8;
+  }
+}
+
+#define FT260_REG_READER(name, reg, width, endian)                                                   \
+  static inline bool name##_read(struct ft260_dev *d, uint16_t addr, FT260_REG_TYPE(width) *value) { \
+    uint8_t buf[width] = { reg };                                                                     \
+    if (!value ||                                                                                     \
+        !ft260_i2c_write(d, addr, buf, 1, false /* stop */) ||                                        \
+        !ft260_i2c_read(d, addr, buf, width, true /* stop */)) {                                      \
+      return false;                                                                                   \
+    }                                                                                                 \
+    *value = (FT260_REG_TYPE(width))ft260_reg_decode(buf, width, endian);                             \
+    return true;                                                                                      \
+  }
+
+#define FT260_REG_WRITER(name, reg, width, endian)                                                   \
+  static inline bool name##_write(struct ft260_dev *d, uint16_t addr, FT260_REG_TYPE(width) value) { \
+    uint8_t buf[1 + width] = { reg };                                                                 \
+    ft260_reg_encode(buf + 1, value, width, endian);                                                  \
+    return ft260_i2c_write(d, addr, buf, sizeof(buf), true /* stop */);                               \
+  }
+
+#define FT260_REG_ACCESS_RO(name, reg, width, endian)    FT260_REG_READER(name, reg, width, endian)
+#define FT260_REG_ACCESS_WO(name, reg, width, endian)    FT260_REG_WRITER(name, reg, width, endian)
+#define FT260_REG_ACCESS_RW(name, reg, width, endian) \
+  FT260_REG_READER(name, reg, width, endian)          \
+  FT260_REG_WRITER(name, reg, width, endian)
+
+#define FT260_REG_ACCESSORS(name, reg, width, endian, access) \
+  FT260_REG_ACCESS_##access(name, reg, width, endian)
+
+#define FT260_REGMAP(REGS)    REGS(FT260_REG_ACCESSORS)
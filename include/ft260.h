@@ -5,6 +5,7 @@
 #include <linux/hidraw.h>
 #include <libudev.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdarg.h>
@@ -33,12 +34,87 @@
 #define FT260_STATUS_IDLE               (0x20)
 #define FT260_STATUS_BUS_BUSY           (0x40)
 
+#define FT260_I2C_WRITE_MAX             (60) // Largest payload of a single I2C write report.
+#define FT260_I2C_READ_MAX              (0xffff) // Largest single I2C read request.
+#define FT260_I2C_POLL_MS               (10)
+#define FT260_I2C_READ_TIMEOUT_MS       (1000)
+
+#define FT260_INT_STATUS_ID             (0xB4) // Input report, bit0 of byte 1 is INTRIN
+#define FT260_INT_STATUS_INTRIN         (0x01)
+
+#define FT260_SMBUS_BLOCK_MAX           (32)
+
+#define FT260_SYSTEM_SETTING_ID         (0xA1)
+#define FT260_SYSTEM_SET_CLOCK          (0x01)
+#define FT260_SYSTEM_SET_I2C_MODE       (0x02)
+#define FT260_SYSTEM_SET_INTERRUPT      (0x05)
+#define FT260_SYSTEM_SET_INT_TRIGGER    (0x0A)
+#define FT260_SYSTEM_SET_POWER_SAVING   (0x10)
+#define FT260_SYSTEM_SET_I2C_RESET      (0x20)
+#define FT260_SYSTEM_SET_I2C_SPEED      (0x22)
+
+enum ft260_endian {
+  FT260_BIG_ENDIAN    = 0,
+  FT260_LITTLE_ENDIAN = 1
+};
+
+enum ft260_clock {
+  FT260_CLOCK_12MHZ = 0,
+  FT260_CLOCK_24MHZ = 1,
+  FT260_CLOCK_48MHZ = 2
+};
+
+enum ft260_int_trigger {
+  FT260_INT_RISING     = 0,
+  FT260_INT_LEVEL_HIGH = 1,
+  FT260_INT_FALLING    = 2,
+  FT260_INT_LEVEL_LOW  = 3
+};
+
+struct ft260_dev;
+typedef void (*ft260_int_cb)(struct ft260_dev *d, void *arg);
+
+/* Decoded SYSTEM_STATUS (0xA1) feature report. */
+struct ft260_system_status {
+  uint8_t          chip_mode;       // DCNF0 and DCNF1 pins, bits 0-1
+  enum ft260_clock clock;
+  bool             suspended;
+  bool             pwren;           // FT260 is ready
+  bool             i2c_enable;
+  uint8_t          uart_mode;
+  bool             hid_over_i2c;
+  uint8_t          gpio2_function;
+  uint8_t          gpioa_function;
+  uint8_t          gpiog_function;
+  bool             suspend_out_active_low;
+  bool             wakeup_int;
+  uint8_t          intr_cond;
+  bool             power_saving;
+};
+
+/* Pending register writes, see ft260_i2c_write_combine(). */
+struct ft260_write_combine {
+  bool     enabled;
+  uint8_t  auto_increment[16];             // Bitmap of 7-bit slave addresses
+  uint16_t addr;
+  uint8_t  len;                            // Pending bytes in buf, including the register
+  uint8_t  buf[FT260_I2C_WRITE_MAX];
+};
+
 struct ft260_dev {
   int                   fd;
   char *                devpath;
   char                  rawname[256];
   struct hidraw_devinfo info;
   uint16_t              freq_khz;
+  uint8_t               i2c_addr;        // Slave of the last START, for continuations
+  enum ft260_clock      clock;
+  bool                  power_saving;
+  struct ft260_write_combine wc;
+  uint8_t               smbus_pec[16];   // Bitmap of 7-bit slave addresses using PEC
+  ft260_int_cb          int_cb;
+  void *                int_arg;
+  unsigned int          int_pending;     // Interrupts seen but not yet dispatched
 };
 
 /* Find an FT260 device in the USB Device List. To get the first FT260, use:
@@ -73,11 +149,58 @@ bool ft260_i2c_get_speed(struct ft260_dev *d, uint16_t *freq_khz);
  */
 bool ft260_i2c_get_status(struct ft260_dev *d, uint8_t *status);
 
+/* Read and decode the SYSTEM_STATUS report. Also refreshes the cached clock
+ * and power saving settings in `d`.
+ * Returns true if the request was successful, false otherwise.
+ */
+bool ft260_get_system_status(struct ft260_dev *d, struct ft260_system_status *status);
+
+/* Set/Get the chip's system clock (12, 24 or 48MHz). A faster clock shortens
+ * the time the chip needs to turn around each report.
+ * Returns true if the clock was set or get successfully, false otherwise.
+ */
+bool ft260_set_clock(struct ft260_dev *d, const enum ft260_clock clock);
+bool ft260_get_clock(struct ft260_dev *d, enum ft260_clock *clock);
+
+/* Enable/Disable power saving mode. When enabled, the chip drops its clock
+ * after being idle for a while, and the first transaction after that pays
+ * for the wakeup.
+ * Returns true if the setting was changed or read successfully, false otherwise.
+ */
+bool ft260_set_power_saving(struct ft260_dev *d, const bool enable);
+bool ft260_get_power_saving(struct ft260_dev *d, bool *enable);
+
 /* Reset I2C Master controller
  * Returns true if successful, false otherwise.
  */
 bool ft260_i2c_reset(struct ft260_dev *d);
 
+/*
+ * Enable or disable write combining in the register helpers. When enabled,
+ * ft260_i2c_write_reg_{b,w,n}() calls to consecutive registers of a slave
+ * that was declared with ft260_i2c_set_auto_increment() are buffered and
+ * sent as a single burst. Pending writes are flushed by ft260_i2c_flush(),
+ * any read or raw write, a reset or settings change, a write to another
+ * slave or a non-consecutive register, or when the burst would exceed one
+ * report. Nothing flushes on idle time, so end each sequence with
+ * ft260_i2c_flush(). Disabling flushes.
+ * Returns true if successful, false otherwise.
+ */
+bool ft260_i2c_write_combine(struct ft260_dev *d, bool enable);
+
+/*
+ * Declare whether slave `addr` auto-increments its register pointer on
+ * multi-byte writes, which allows its register writes to be combined.
+ */
+void ft260_i2c_set_auto_increment(struct ft260_dev *d, uint16_t addr, bool enable);
+
+/*
+ * Write out any register writes held back by write combining (a barrier).
+ * Returns true if there was nothing to write or the write succeeded,
+ * false otherwise. Pending writes are dropped either way.
+ */
+bool ft260_i2c_flush(struct ft260_dev *d);
+
 /*
  * Read specified number of bytes from the specified address.
  * Address should not include the R/W bit. If addr is -1, START is not
@@ -94,6 +217,14 @@ bool ft260_i2c_read(struct ft260_dev *d, uint16_t addr, void *data, size_t len,
  */
 bool ft260_i2c_write(struct ft260_dev *d, uint16_t addr, const void *data, size_t len, bool stop);
 
+/*
+ * Address slave `addr` with an empty write and release the bus. A NACK is
+ * an expected outcome and is not logged as an error, which makes this
+ * suitable for bus scans and EEPROM ACK polling.
+ * Returns `true` if the slave acknowledged, `false` otherwise.
+ */
+bool ft260_i2c_probe(struct ft260_dev *d, uint16_t addr);
+
 /*
  * Release the bus (when left unreleased after read or write).
  */
@@ -122,6 +253,28 @@ bool ft260_i2c_read_reg_w(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint1
  */
 bool ft260_i2c_read_reg_n(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t n, uint8_t *buf);
 
+/*
+ * Helpers for reading `count` consecutive 16-, 24- or 32-bit samples starting
+ * at register `reg` (e.g. an ADC or IMU FIFO) in a single transfer. Samples
+ * are stored on the device with the given `endian`ness and are returned in
+ * host order in `values`; 24-bit samples are zero-extended.
+ * Returns `true` in case of success, `false` otherwise.
+ */
+bool ft260_i2c_read_reg_u16(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint16_t *values);
+bool ft260_i2c_read_reg_u24(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint32_t *values);
+bool ft260_i2c_read_reg_u32(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint32_t *values);
+
+/*
+ * Convert `count` raw samples in `src` to host order in `dst`, using SSE2 or
+ * SSSE3 (detected at runtime on x86) where available and scalar code
+ * otherwise. Conversion may happen in place: `src` may equal `dst` for 16-
+ * and 32-bit samples, and may point `count` bytes into `dst` for 24-bit
+ * samples.
+ */
+void ft260_decode_u16(const uint8_t *src, size_t count, enum ft260_endian endian, uint16_t *dst);
+void ft260_decode_u24(const uint8_t *src, size_t count, enum ft260_endian endian, uint32_t *dst);
+void ft260_decode_u32(const uint8_t *src, size_t count, enum ft260_endian endian, uint32_t *dst);
+
 /*
  * Helper for writing 1-byte register `reg` to a device at address `addr`.
  * Returns `true` in case of success, `false` otherwise.
@@ -141,3 +294,98 @@ bool ft260_i2c_write_reg_w(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint
  * Returns `true` in case of success, `false` otherwise.
  */
 bool ft260_i2c_write_reg_n(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t n, const uint8_t *buf);
+
+/*
+ * 24Cxx-style EEPROM geometry. `addr` is the base slave address; address
+ * bits that don't fit in `addr_width` bytes (e.g. the block select bits of a
+ * 24C16, or A16 of a 24C1024) are folded into the slave address.
+ * `write_cycle_ms` bounds the ACK polling after each page write (0 means 10ms).
+ * `bytes_per_sec` is filled in with the throughput of the last operation.
+ */
+struct ft260_eeprom {
+  uint16_t addr;
+  uint16_t page_size;
+  uint8_t  addr_width;
+  uint32_t size;
+  uint32_t write_cycle_ms;
+  uint32_t bytes_per_sec;
+};
+
+/*
+ * Write `len` bytes from `buf` to the EEPROM at `offset`. Writes are split at
+ * page boundaries and each page is followed by ACK polling, so the next page
+ * starts as soon as the write cycle has completed.
+ * Returns `true` in case of success, `false` otherwise.
+ */
+bool ft260_eeprom_write(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, const uint8_t *buf, size_t len);
+
+/*
+ * Read `len` bytes from the EEPROM at `offset` into `buf`, using sequential
+ * reads as large as the device allows.
+ * Returns `true` in case of success, `false` otherwise.
+ */
+bool ft260_eeprom_read(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, uint8_t *buf, size_t len);
+
+/*
+ * Read back `len` bytes from the EEPROM at `offset` and compare against `buf`.
+ * Returns `true` if the contents match, `false` on mismatch or error.
+ */
+bool ft260_eeprom_verify(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, const uint8_t *buf, size_t len);
+
+/*
+ * SMBus protocol helpers. Each runs as a single I2C transaction, with a
+ * repeated start between the write and read phases. Words are little-endian
+ * as per the SMBus specification. For slaves that have PEC enabled with
+ * ft260_smbus_set_pec(), it is appended to writes and checked on reads.
+ * All return `true` in case of success, `false` otherwise (including a PEC
+ * mismatch).
+ */
+void ft260_smbus_set_pec(struct ft260_dev *d, uint16_t addr, bool enable);
+bool ft260_smbus_quick(struct ft260_dev *d, uint16_t addr, bool read);
+bool ft260_smbus_send_byte(struct ft260_dev *d, uint16_t addr, uint8_t value);
+bool ft260_smbus_receive_byte(struct ft260_dev *d, uint16_t addr, uint8_t *value);
+bool ft260_smbus_write_byte(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t value);
+bool ft260_smbus_read_byte(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t *value);
+bool ft260_smbus_write_word(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t value);
+bool ft260_smbus_read_word(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t *value);
+bool ft260_smbus_process_call(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t value, uint16_t *result);
+
+/*
+ * Block transfers of up to FT260_SMBUS_BLOCK_MAX bytes. For reads, `*len`
+ * holds the size of `buf` on entry and the number of bytes received on return.
+ */
+bool ft260_smbus_write_block(struct ft260_dev *d, uint16_t addr, uint8_t cmd, const uint8_t *buf, size_t len);
+bool ft260_smbus_read_block(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t *buf, size_t *len);
+bool ft260_smbus_block_process_call(struct ft260_dev *d, uint16_t addr, uint8_t cmd, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t *rlen);
+
+/*
+ * Table-driven SMBus PEC (CRC-8) over `len` bytes, continuing from `crc`.
+ */
+uint8_t ft260_smbus_crc8(uint8_t crc, const uint8_t *data, size_t len);
+
+/*
+ * Decode PMBus LINEAR11 values (e.g. READ_IOUT), and LINEAR16 values (e.g.
+ * READ_VOUT) using the exponent from VOUT_MODE.
+ */
+float ft260_pmbus_linear11(uint16_t value);
+float ft260_pmbus_linear16(uint16_t value, uint8_t vout_mode);
+
+/*
+ * Enable the INTRIN interrupt input (GPIO3). `trigger` selects the edge or
+ * level, and `duration` the minimum level duration for level triggers
+ * (1 = 1ms, 2 = 5ms, 3 = 30ms). The chip reports each interrupt as an input
+ * report on the same hidraw fd, and `cb` is called with `arg` for each one
+ * from ft260_int_poll(). Interrupts that arrive during an I2C read are
+ * remembered and dispatched by the next ft260_int_poll().
+ * Returns true if successful, false otherwise.
+ */
+bool ft260_int_enable(struct ft260_dev *d, enum ft260_int_trigger trigger, uint8_t duration, ft260_int_cb cb, void *arg);
+bool ft260_int_disable(struct ft260_dev *d);
+
+/*
+ * Flush pending combined writes, then wait up to `timeout_ms` (-1 waits
+ * forever) for interrupts and call the callback for each one. The callback
+ * may perform I2C transfers.
+ * Returns the number of interrupts dispatched, or -1 on error.
+ */
+int ft260_int_poll(struct ft260_dev *d, int timeout_ms);
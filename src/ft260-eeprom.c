@@ -0,0 +1,192 @@
+#include <time.h>
+#include "mgos.h"
+#include "ft260.h"
+
+#define FT260_EEPROM_WRITE_CYCLE_MS    (10)
+
+static uint64_t ft260_eeprom_now_us(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool ft260_eeprom_check(const struct ft260_eeprom *e, uint32_t offset, size_t len) {
+  if (!e || e->addr_width < 1 || e->addr_width > 2 || e->page_size == 0) {
+    LOG(LL_ERROR, ("Invalid EEPROM geometry"));
+    return false;
+  }
+  if (offset > e->size || len > e->size - offset) {
+    LOG(LL_ERROR, ("Access of %zu bytes at 0x%x is beyond EEPROM size %u", len, offset, e->size));
+    return false;
+  }
+  return true;
+}
+
+// Size of the window addressable without changing the slave address.
+static uint32_t ft260_eeprom_block_size(const struct ft260_eeprom *e) {
+  return 1UL << (8 * e->addr_width);
+}
+
+// Build the slave address and memory address bytes for `offset` into `hdr`.
+static uint16_t ft260_eeprom_address(const struct ft260_eeprom *e, uint32_t offset, uint8_t *hdr) {
+  if (e->addr_width == 2) {
+    hdr[0] = (uint8_t)(offset >> 8);
+    hdr[1] = (uint8_t)offset;
+  } else {
+    hdr[0] = (uint8_t)offset;
+  }
+  return e->addr | (offset >> (8 * e->addr_width));
+}
+
+static void ft260_eeprom_report(struct ft260_eeprom *e, const char *op, size_t len, uint64_t start_us, uint32_t polls) {
+  uint64_t elapsed = ft260_eeprom_now_us() - start_us;
+
+  e->bytes_per_sec = elapsed ? (uint32_t)(len * 1000000ULL / elapsed) : 0;
+  LOG(LL_INFO, ("%s %zu bytes in %.1fms: %u bytes/sec, %u ACK polls", op, len, elapsed / 1000.0, e->bytes_per_sec, polls));
+}
+
+/* Poll the slave with empty writes until it ACKs, meaning the internal write
+ * cycle has completed. Returns the number of polls, or -1 on timeout.
+ */
+static int ft260_eeprom_ack_poll(struct ft260_dev *d, const struct ft260_eeprom *e, uint16_t addr) {
+  uint64_t timeout_us = 1000ULL * (e->write_cycle_ms ? e->write_cycle_ms : FT260_EEPROM_WRITE_CYCLE_MS);
+  uint64_t start      = ft260_eeprom_now_us();
+  int      polls      = 0;
+
+  do {
+    polls++;
+    if (ft260_i2c_probe(d, addr)) {
+      return polls;
+    }
+  } while (ft260_eeprom_now_us() - start < timeout_us);
+
+  LOG(LL_ERROR, ("EEPROM at 0x%02x did not complete its write cycle in %lluus", addr, (unsigned long long)timeout_us));
+  return -1;
+}
+
+/* Write the memory address in `hdr` followed by `len` data bytes as a single
+ * I2C transaction, so that a whole page takes one write cycle. Data that
+ * does not fit in the first report follows in continuation reports.
+ */
+static bool ft260_eeprom_write_page(struct ft260_dev *d, uint16_t addr, const uint8_t *hdr, size_t hdr_len, const uint8_t *data, size_t len) {
+  uint8_t tmp[FT260_I2C_WRITE_MAX];
+  size_t  done = len;
+  bool    ok;
+
+  if (done > FT260_I2C_WRITE_MAX - hdr_len) {
+    done = FT260_I2C_WRITE_MAX - hdr_len;
+  }
+  memcpy(tmp, hdr, hdr_len);
+  memcpy(tmp + hdr_len, data, done);
+  ok = ft260_i2c_write(d, addr, tmp, hdr_len + done, done == len /* stop */);
+  while (ok && done < len) {
+    size_t chunk = len - done;
+
+    if (chunk > FT260_I2C_WRITE_MAX) {
+      chunk = FT260_I2C_WRITE_MAX;
+    }
+    ok    = ft260_i2c_write(d, (uint16_t)-1, data + done, chunk, done + chunk == len /* stop */);
+    done += chunk;
+  }
+  if (!ok) {
+    // Don't leave the bus held in the middle of a page.
+    ft260_i2c_reset(d);
+  }
+  return ok;
+}
+
+bool ft260_eeprom_write(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, const uint8_t *buf, size_t len) {
+  uint8_t  hdr[2];
+  uint64_t start = ft260_eeprom_now_us();
+  uint32_t polls = 0;
+  size_t   done  = 0;
+
+  if (!d || (!buf && len > 0) || !ft260_eeprom_check(e, offset, len)) {
+    return false;
+  }
+
+  while (done < len) {
+    uint32_t pos   = offset + done;
+    size_t   chunk = e->page_size - (pos % e->page_size);
+    uint16_t addr;
+    int      res;
+
+    if (chunk > len - done) {
+      chunk = len - done;
+    }
+    addr = ft260_eeprom_address(e, pos, hdr);
+    if (!ft260_eeprom_write_page(d, addr, hdr, e->addr_width, buf + done, chunk)) {
+      LOG(LL_ERROR, ("EEPROM write of %zu bytes at 0x%x failed", chunk, pos));
+      return false;
+    }
+    if ((res = ft260_eeprom_ack_poll(d, e, addr)) < 0) {
+      return false;
+    }
+    polls += res;
+    done  += chunk;
+  }
+
+  ft260_eeprom_report(e, "Wrote", len, start, polls);
+  return true;
+}
+
+bool ft260_eeprom_read(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, uint8_t *buf, size_t len) {
+  uint8_t  hdr[2];
+  uint64_t start = ft260_eeprom_now_us();
+  uint32_t block;
+  size_t   done  = 0;
+
+  if (!d || (!buf && len > 0) || !ft260_eeprom_check(e, offset, len)) {
+    return false;
+  }
+  block = ft260_eeprom_block_size(e);
+
+  // Sequential reads may wrap within a block, so don't cross one.
+  while (done < len) {
+    uint32_t pos   = offset + done;
+    size_t   chunk = block - (pos % block);
+    uint16_t addr;
+
+    if (chunk > len - done) {
+      chunk = len - done;
+    }
+    if (chunk > FT260_I2C_READ_MAX) {
+      chunk = FT260_I2C_READ_MAX;
+    }
+    addr = ft260_eeprom_address(e, pos, hdr);
+    if (!ft260_i2c_write(d, addr, hdr, e->addr_width, false /* stop */) ||
+        !ft260_i2c_read(d, addr, buf + done, chunk, true /* stop */)) {
+      LOG(LL_ERROR, ("EEPROM read of %zu bytes at 0x%x failed", chunk, pos));
+      return false;
+    }
+    done += chunk;
+  }
+
+  ft260_eeprom_report(e, "Read", len, start, 0);
+  return true;
+}
+
+bool ft260_eeprom_verify(struct ft260_dev *d, struct ft260_eeprom *e, uint32_t offset, const uint8_t *buf, size_t len) {
+  uint8_t *tmp;
+  bool     res = false;
+
+  if (!buf && len > 0) {
+    return false;
+  }
+  if (!(tmp = malloc(len ? len : 1))) {
+    return false;
+  }
+  if (ft260_eeprom_read(d, e, offset, tmp, len)) {
+    res = true;
+    for (size_t i = 0; i < len; i++) {
+      if (tmp[i] != buf[i]) {
+        LOG(LL_ERROR, ("EEPROM mismatch at 0x%zx: read 0x%02x, expected 0x%02x", offset + i, tmp[i], buf[i]));
+        res = false;
+        break;
+      }
+    }
+  }
+  free(tmp);
+  return res;
+}
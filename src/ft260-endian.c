@@ -0,0 +1,117 @@
+#include "mgos.h"
+#include "ft260.h"
+
+#if defined(__SSE2__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <emmintrin.h>
+#define FT260_HAVE_SSE2 1
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define FT260_HAVE_SSSE3 1
+#endif
+
+/* The decoders below walk forward and load each block before storing it, so
+ * they may run in place: `src` may equal `dst` for 16- and 32-bit samples,
+ * and may point `count` bytes into `dst` for 24-bit samples.
+ */
+
+void ft260_decode_u16(const uint8_t *src, size_t count, enum ft260_endian endian, uint16_t *dst) {
+  size_t i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (endian == FT260_LITTLE_ENDIAN) {
+    memmove(dst, src, count * 2);
+    return;
+  }
+#endif
+#ifdef FT260_HAVE_SSE2
+  if (endian == FT260_BIG_ENDIAN) {
+    for (; i + 8 <= count; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t *p = src + i * 2;
+    if (endian == FT260_BIG_ENDIAN) {
+      dst[i] = ((uint16_t)p[0] << 8) | p[1];
+    } else {
+      dst[i] = ((uint16_t)p[1] << 8) | p[0];
+    }
+  }
+}
+
+#ifdef FT260_HAVE_SSSE3
+/* Decode as many 24-bit samples as the SSSE3 loop can handle, returning how
+ * many were done. Built for SSSE3 regardless of the compiler flags, so only
+ * call it after checking the CPU supports it.
+ */
+__attribute__((target("ssse3")))
+static size_t ft260_decode_u24_ssse3(const uint8_t *src, size_t count, enum ft260_endian endian, uint32_t *dst) {
+  size_t i = 0;
+
+  // Spread four 3-byte samples into four 32-bit lanes, zeroing the top byte.
+  const __m128i shuf = (endian == FT260_BIG_ENDIAN)
+    ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+    : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+  // Each load reads 16 bytes but consumes 12, so stop two samples early.
+  for (; i + 6 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, shuf));
+  }
+  return i;
+}
+#endif
+
+void ft260_decode_u24(const uint8_t *src, size_t count, enum ft260_endian endian, uint32_t *dst) {
+  size_t i = 0;
+
+#if defined(FT260_HAVE_SSSE3) && defined(__SSSE3__)
+  i = ft260_decode_u24_ssse3(src, count, endian, dst);
+#elif defined(FT260_HAVE_SSSE3)
+  if (__builtin_cpu_supports("ssse3")) {
+    i = ft260_decode_u24_ssse3(src, count, endian, dst);
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t *p = src + i * 3;
+    if (endian == FT260_BIG_ENDIAN) {
+      dst[i] = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    } else {
+      dst[i] = ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+    }
+  }
+}
+
+void ft260_decode_u32(const uint8_t *src, size_t count, enum ft260_endian endian, uint32_t *dst) {
+  size_t i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (endian == FT260_LITTLE_ENDIAN) {
+    memmove(dst, src, count * 4);
+    return;
+  }
+#endif
+#ifdef FT260_HAVE_SSE2
+  if (endian == FT260_BIG_ENDIAN) {
+    for (; i + 4 <= count; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+      // Swap the bytes in each 16-bit half, then swap the halves.
+      v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+      v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+      _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t *p = src + i * 4;
+    if (endian == FT260_BIG_ENDIAN) {
+      dst[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    } else {
+      dst[i] = ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+    }
+  }
+}
@@ -1,6 +1,76 @@
 #include "mgos.h"
 #include "ft260.h"
 
+static bool ft260_i2c_is_auto_increment(struct ft260_dev *d, uint16_t addr) {
+  return addr < 128 && (d->wc.auto_increment[addr / 8] & (1 << (addr % 8)));
+}
+
+void ft260_i2c_set_auto_increment(struct ft260_dev *d, uint16_t addr, bool enable) {
+  if (!d || addr >= 128) {
+    return;
+  }
+  if (enable) {
+    d->wc.auto_increment[addr / 8] |= (1 << (addr % 8));
+  } else {
+    d->wc.auto_increment[addr / 8] &= ~(1 << (addr % 8));
+  }
+}
+
+bool ft260_i2c_write_combine(struct ft260_dev *d, bool enable) {
+  if (!d) {
+    return false;
+  }
+  if (!enable && !ft260_i2c_flush(d)) {
+    return false;
+  }
+  d->wc.enabled = enable;
+  return true;
+}
+
+bool ft260_i2c_flush(struct ft260_dev *d) {
+  uint8_t len;
+
+  if (!d || d->wc.len == 0) {
+    return true;
+  }
+  // Clear before writing, ft260_i2c_write() flushes too.
+  len       = d->wc.len;
+  d->wc.len = 0;
+  LOG(LL_DEBUG, ("Flushing %u combined register bytes to 0x%02x reg 0x%02x", len - 1, d->wc.addr, d->wc.buf[0]));
+  return ft260_i2c_write(d, d->wc.addr, d->wc.buf, len, true /* stop */);
+}
+
+/* Queue a write of `n` bytes to register `reg` if write combining applies.
+ * Returns true if the write was handled, with `*res` set to whether it was
+ * queued. If flushing the previous burst fails, this write is not queued and
+ * `*res` is false. Returns false if the caller should write directly.
+ */
+static bool ft260_i2c_write_queue(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t n, const uint8_t *buf, bool *res) {
+  struct ft260_write_combine *wc = &d->wc;
+
+  *res = true;
+  if (!wc->enabled || !ft260_i2c_is_auto_increment(d, addr) || n + 1 > FT260_I2C_WRITE_MAX) {
+    return false;
+  }
+  if (wc->len > 0 &&
+      (wc->addr != addr ||
+       wc->buf[0] + wc->len - 1 != reg ||
+       wc->len + n > FT260_I2C_WRITE_MAX)) {
+    if (!ft260_i2c_flush(d)) {
+      *res = false;
+      return true;
+    }
+  }
+  if (wc->len == 0) {
+    wc->addr   = addr;
+    wc->buf[0] = reg;
+    wc->len    = 1;
+  }
+  memcpy(wc->buf + wc->len, buf, n);
+  wc->len += n;
+  return true;
+}
+
 // Primitives: Read and Write 'n' bytes from 'buf' to register 'reg'.
 bool ft260_i2c_read_reg_n(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t n, uint8_t *buf) {
   return ft260_i2c_write(d, addr, &reg, 1, false /* stop */) &&
@@ -8,16 +78,18 @@ bool ft260_i2c_read_reg_n(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_
 }
 
 bool ft260_i2c_write_reg_n(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t n, const uint8_t *buf) {
-  bool     res = false;
-  uint8_t *tmp = calloc(n + 1, 1);
+  bool    res;
+  uint8_t tmp[FT260_I2C_WRITE_MAX];
 
-  if (tmp) {
-    *tmp = reg;
-    memcpy(tmp + 1, buf, n);
-    res = ft260_i2c_write(d, addr, tmp, n + 1, true /* stop */);
-    free(tmp);
+  if (!d || n + 1 > sizeof(tmp)) {
+    return false;
   }
-  return res;
+  if (ft260_i2c_write_queue(d, addr, reg, n, buf, &res)) {
+    return res;
+  }
+  tmp[0] = reg;
+  memcpy(tmp + 1, buf, n);
+  return ft260_i2c_write(d, addr, tmp, n + 1, true /* stop */);
 }
 
 // Derivatives: Read/Write one byte and one word to register 'reg'.
@@ -34,7 +106,11 @@ bool ft260_i2c_read_reg_b(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint8
 
 bool ft260_i2c_write_reg_b(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint8_t value) {
   uint8_t tmp[2] = { reg, value };
+  bool    res;
 
+  if (d && ft260_i2c_write_queue(d, addr, reg, 1, tmp + 1, &res)) {
+    return res;
+  }
   return ft260_i2c_write(d, addr, tmp, sizeof(tmp), true /* stop */);
 }
 
@@ -54,6 +130,47 @@ bool ft260_i2c_read_reg_w(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint1
 
 bool ft260_i2c_write_reg_w(struct ft260_dev *d, uint16_t addr, uint8_t reg, uint16_t value) {
   uint8_t tmp[3] = { reg, (uint8_t)(value >> 8), (uint8_t)value };
+  bool    res;
 
+  if (d && ft260_i2c_write_queue(d, addr, reg, 2, tmp + 1, &res)) {
+    return res;
+  }
   return ft260_i2c_write(d, addr, tmp, sizeof(tmp), true /* stop */);
 }
+
+// Arrays: Read `count` samples in one transfer and convert them in place.
+bool ft260_i2c_read_reg_u16(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint16_t *values) {
+  if (!values || count > FT260_I2C_READ_MAX / 2) {
+    return false;
+  }
+  if (!ft260_i2c_read_reg_n(d, addr, reg, count * 2, (uint8_t *)values)) {
+    return false;
+  }
+  ft260_decode_u16((const uint8_t *)values, count, endian, values);
+  return true;
+}
+
+bool ft260_i2c_read_reg_u24(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint32_t *values) {
+  uint8_t *raw;
+
+  if (!values || count > FT260_I2C_READ_MAX / 3) {
+    return false;
+  }
+  raw = (uint8_t *)values + count; // 3 bytes per sample, at the tail of `values`.
+  if (!ft260_i2c_read_reg_n(d, addr, reg, count * 3, raw)) {
+    return false;
+  }
+  ft260_decode_u24(raw, count, endian, values);
+  return true;
+}
+
+bool ft260_i2c_read_reg_u32(struct ft260_dev *d, uint16_t addr, uint8_t reg, size_t count, enum ft260_endian endian, uint32_t *values) {
+  if (!values || count > FT260_I2C_READ_MAX / 4) {
+    return false;
+  }
+  if (!ft260_i2c_read_reg_n(d, addr, reg, count * 4, (uint8_t *)values)) {
+    return false;
+  }
+  ft260_decode_u32((const uint8_t *)values, count, endian, values);
+  return true;
+}
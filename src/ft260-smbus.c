@@ -0,0 +1,236 @@
+#include <math.h>
+#include "mgos.h"
+#include "ft260.h"
+
+// CRC-8, polynomial x^8 + x^2 + x + 1, as used by SMBus PEC.
+static const uint8_t ft260_smbus_crc8_table[256] = {
+  0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+  0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+  0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+  0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+  0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+  0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+  0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+  0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+  0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+  0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+  0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+  0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+  0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+  0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+  0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+  0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
+};
+
+uint8_t ft260_smbus_crc8(uint8_t crc, const uint8_t *data, size_t len) {
+  while (len--) {
+    crc = ft260_smbus_crc8_table[crc ^ *data++];
+  }
+  return crc;
+}
+
+static uint8_t ft260_smbus_crc8_addr(uint8_t crc, uint16_t addr, bool read) {
+  uint8_t a = (uint8_t)((addr << 1) | (read ? 1 : 0));
+
+  return ft260_smbus_crc8(crc, &a, 1);
+}
+
+void ft260_smbus_set_pec(struct ft260_dev *d, uint16_t addr, bool enable) {
+  if (!d || addr >= 128) {
+    return;
+  }
+  if (enable) {
+    d->smbus_pec[addr / 8] |= (1 << (addr % 8));
+  } else {
+    d->smbus_pec[addr / 8] &= ~(1 << (addr % 8));
+  }
+}
+
+static bool ft260_smbus_pec(struct ft260_dev *d, uint16_t addr) {
+  return addr < 128 && (d->smbus_pec[addr / 8] & (1 << (addr % 8)));
+}
+
+// Write `len` bytes, followed by PEC if enabled, and release the bus.
+static bool ft260_smbus_write(struct ft260_dev *d, uint16_t addr, const uint8_t *data, size_t len) {
+  uint8_t buf[FT260_SMBUS_BLOCK_MAX + 3]; // command, count, data, PEC
+
+  if (!d || len > sizeof(buf) - 1) {
+    return false;
+  }
+  memcpy(buf, data, len);
+  if (ft260_smbus_pec(d, addr)) {
+    buf[len] = ft260_smbus_crc8(ft260_smbus_crc8_addr(0, addr, false), buf, len);
+    len++;
+  }
+  return ft260_i2c_write(d, addr, buf, len, true /* stop */);
+}
+
+/* Write `wlen` bytes (if any) without releasing the bus, then read `rlen`
+ * bytes after a repeated start, followed by PEC if enabled.
+ */
+static bool ft260_smbus_read(struct ft260_dev *d, uint16_t addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen) {
+  uint8_t buf[FT260_SMBUS_BLOCK_MAX + 2];
+  uint8_t crc = 0;
+
+  if (!d || rlen > sizeof(buf) - 1) {
+    return false;
+  }
+  if (wlen > 0 && !ft260_i2c_write(d, addr, wbuf, wlen, false /* stop */)) {
+    return false;
+  }
+  if (!ft260_i2c_read(d, addr, buf, rlen + (ft260_smbus_pec(d, addr) ? 1 : 0), true /* stop */)) {
+    return false;
+  }
+  if (ft260_smbus_pec(d, addr)) {
+    if (wlen > 0) {
+      crc = ft260_smbus_crc8(ft260_smbus_crc8_addr(0, addr, false), wbuf, wlen);
+    }
+    crc = ft260_smbus_crc8(ft260_smbus_crc8_addr(crc, addr, true), buf, rlen);
+    if (crc != buf[rlen]) {
+      LOG(LL_ERROR, ("PEC mismatch from 0x%02x: got 0x%02x, want 0x%02x", addr, buf[rlen], crc));
+      return false;
+    }
+  }
+  memcpy(rbuf, buf, rlen);
+  return true;
+}
+
+/* Read a count byte and that many data bytes (plus PEC) after `wbuf` was
+ * written. The count is read without releasing the bus, and the data
+ * continues the same read without a new START.
+ */
+static bool ft260_smbus_read_counted(struct ft260_dev *d, uint16_t addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t *rlen) {
+  uint8_t buf[FT260_SMBUS_BLOCK_MAX + 2]; // count, data, PEC
+  size_t  n;
+  uint8_t crc;
+
+  if (!d || !rbuf || !rlen) {
+    return false;
+  }
+  // Each failure below leaves the bus held, so reset the controller to release it.
+  if (!ft260_i2c_write(d, addr, wbuf, wlen, false /* stop */) ||
+      !ft260_i2c_read(d, addr, buf, 1, false /* stop */)) {
+    ft260_i2c_reset(d);
+    return false;
+  }
+  if (buf[0] > FT260_SMBUS_BLOCK_MAX || buf[0] > *rlen) {
+    LOG(LL_ERROR, ("Block of %u bytes from 0x%02x does not fit in %zu bytes", buf[0], addr, *rlen));
+    ft260_i2c_reset(d);
+    return false;
+  }
+  n = buf[0] + (ft260_smbus_pec(d, addr) ? 1 : 0);
+  if (!ft260_i2c_read(d, (uint16_t)-1, buf + 1, n, true /* stop */)) {
+    ft260_i2c_reset(d);
+    return false;
+  }
+  if (ft260_smbus_pec(d, addr)) {
+    crc = ft260_smbus_crc8(ft260_smbus_crc8_addr(0, addr, false), wbuf, wlen);
+    crc = ft260_smbus_crc8(ft260_smbus_crc8_addr(crc, addr, true), buf, buf[0] + 1);
+    if (crc != buf[buf[0] + 1]) {
+      LOG(LL_ERROR, ("PEC mismatch from 0x%02x: got 0x%02x, want 0x%02x", addr, buf[buf[0] + 1], crc));
+      return false;
+    }
+  }
+  memcpy(rbuf, buf + 1, buf[0]);
+  *rlen = buf[0];
+  return true;
+}
+
+bool ft260_smbus_quick(struct ft260_dev *d, uint16_t addr, bool read) {
+  if (read) {
+    return ft260_i2c_read(d, addr, NULL, 0, true /* stop */);
+  }
+  return ft260_i2c_write(d, addr, NULL, 0, true /* stop */);
+}
+
+bool ft260_smbus_send_byte(struct ft260_dev *d, uint16_t addr, uint8_t value) {
+  return ft260_smbus_write(d, addr, &value, 1);
+}
+
+bool ft260_smbus_receive_byte(struct ft260_dev *d, uint16_t addr, uint8_t *value) {
+  if (!value) {
+    return false;
+  }
+  return ft260_smbus_read(d, addr, NULL, 0, value, 1);
+}
+
+bool ft260_smbus_write_byte(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t value) {
+  uint8_t tmp[2] = { cmd, value };
+
+  return ft260_smbus_write(d, addr, tmp, sizeof(tmp));
+}
+
+bool ft260_smbus_read_byte(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t *value) {
+  if (!value) {
+    return false;
+  }
+  return ft260_smbus_read(d, addr, &cmd, 1, value, 1);
+}
+
+bool ft260_smbus_write_word(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t value) {
+  uint8_t tmp[3] = { cmd, (uint8_t)value, (uint8_t)(value >> 8) };
+
+  return ft260_smbus_write(d, addr, tmp, sizeof(tmp));
+}
+
+bool ft260_smbus_read_word(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t *value) {
+  uint8_t tmp[2];
+
+  if (!value || !ft260_smbus_read(d, addr, &cmd, 1, tmp, sizeof(tmp))) {
+    return false;
+  }
+  *value = (((uint16_t)tmp[1]) << 8) | tmp[0];
+  return true;
+}
+
+bool ft260_smbus_process_call(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint16_t value, uint16_t *result) {
+  uint8_t wbuf[3] = { cmd, (uint8_t)value, (uint8_t)(value >> 8) };
+  uint8_t rbuf[2];
+
+  if (!result || !ft260_smbus_read(d, addr, wbuf, sizeof(wbuf), rbuf, sizeof(rbuf))) {
+    return false;
+  }
+  *result = (((uint16_t)rbuf[1]) << 8) | rbuf[0];
+  return true;
+}
+
+bool ft260_smbus_write_block(struct ft260_dev *d, uint16_t addr, uint8_t cmd, const uint8_t *buf, size_t len) {
+  uint8_t tmp[FT260_SMBUS_BLOCK_MAX + 2];
+
+  if ((!buf && len > 0) || len > FT260_SMBUS_BLOCK_MAX) {
+    return false;
+  }
+  tmp[0] = cmd;
+  tmp[1] = (uint8_t)len;
+  memcpy(tmp + 2, buf, len);
+  return ft260_smbus_write(d, addr, tmp, len + 2);
+}
+
+bool ft260_smbus_read_block(struct ft260_dev *d, uint16_t addr, uint8_t cmd, uint8_t *buf, size_t *len) {
+  return ft260_smbus_read_counted(d, addr, &cmd, 1, buf, len);
+}
+
+bool ft260_smbus_block_process_call(struct ft260_dev *d, uint16_t addr, uint8_t cmd, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t *rlen) {
+  uint8_t tmp[FT260_SMBUS_BLOCK_MAX + 2];
+
+  if ((!wbuf && wlen > 0) || wlen > FT260_SMBUS_BLOCK_MAX) {
+    return false;
+  }
+  tmp[0] = cmd;
+  tmp[1] = (uint8_t)wlen;
+  memcpy(tmp + 2, wbuf, wlen);
+  return ft260_smbus_read_counted(d, addr, tmp, wlen + 2, rbuf, rlen);
+}
+
+float ft260_pmbus_linear11(uint16_t value) {
+  int16_t exponent = (int16_t)value >> 11;
+  int16_t mantissa = (int16_t)(value << 5) >> 5;
+
+  return ldexpf(mantissa, exponent);
+}
+
+float ft260_pmbus_linear16(uint16_t value, uint8_t vout_mode) {
+  int8_t exponent = (int8_t)(vout_mode << 3) >> 3;
+
+  return ldexpf(value, exponent);
+}
@@ -21,6 +21,18 @@ static const char *ft260_bus_type_str(int bus) {
   }
 }
 
+static const char *ft260_clock_str(enum ft260_clock clock) {
+  switch (clock) {
+  case FT260_CLOCK_12MHZ: return "12MHz";
+
+  case FT260_CLOCK_24MHZ: return "24MHz";
+
+  case FT260_CLOCK_48MHZ: return "48MHz";
+
+  default: return "Unknown";
+  }
+}
+
 /* Send or retrieve a feature to/from the HID.
  *
  * direction:  OUTPUT is output (write to HID), INPUT = input (read from HID)
@@ -68,6 +80,65 @@ static bool ft260_i2c_wait(struct ft260_dev *d) {
   return false;
 }
 
+/* Fetch the controller status and check the outcome of the last operation.
+ * If `probe` is set, a slave address NACK is expected and not logged as an
+ * error.
+ * Returns false if the controller is still busy or reported an error.
+ */
+static bool ft260_i2c_check_status(struct ft260_dev *d, bool probe) {
+  uint8_t status = 0;
+
+  if (!ft260_i2c_get_status(d, &status)) {
+    return false;
+  }
+  LOG(LL_DEBUG, ("Status: 0x%02x", status));
+
+  if (status & FT260_STATUS_MASTER_BUSY) {
+    LOG(LL_DEBUG, ("Status: controller busy"));
+    return false;
+  }
+  if (probe && (status & FT260_STATUS_ERROR) && (status & FT260_STATUS_ERROR_SLAVE_ACK)) {
+    LOG(LL_DEBUG, ("Status: slave not acknowledging"));
+    return false;
+  }
+  if (status & FT260_STATUS_ERROR) {
+    LOG(LL_ERROR, ("Error: Error condition: %s %s %s",
+                   (status & FT260_STATUS_ERROR_SLAVE_ACK ? "(slave_ack)" : ""),
+                   (status & FT260_STATUS_ERROR_DATA_ACK ? "(data_ack)" : ""),
+                   (status & FT260_STATUS_ERROR_LOST ? "(lost)" : "")));
+    return false;
+  }
+  if (status & FT260_STATUS_BUS_BUSY) {
+    LOG(LL_DEBUG, ("Status: I2C Bus Busy"));
+  }
+  return true;
+}
+
+/* Decode a raw SYSTEM_STATUS report, refreshing the cached clock and power
+ * saving settings in `d`. `status` may be NULL.
+ */
+static void ft260_decode_system_status(struct ft260_dev *d, const uint8_t *buf, struct ft260_system_status *status) {
+  d->clock        = (enum ft260_clock)(buf[2] & 0x03);
+  d->power_saving = buf[14] != 0;
+  if (!status) {
+    return;
+  }
+  status->chip_mode              = buf[1] & 0x03;
+  status->clock                  = d->clock;
+  status->suspended              = buf[3] != 0;
+  status->pwren                  = buf[4] != 0;
+  status->i2c_enable             = buf[5] != 0;
+  status->uart_mode              = buf[6];
+  status->hid_over_i2c           = buf[7] != 0;
+  status->gpio2_function         = buf[8];
+  status->gpioa_function         = buf[9];
+  status->gpiog_function         = buf[10];
+  status->suspend_out_active_low = buf[11] != 0;
+  status->wakeup_int             = buf[12] != 0;
+  status->intr_cond              = buf[13];
+  status->power_saving           = d->power_saving;
+}
+
 char *ft260_get_hidpath(const unsigned short vendor_id, const unsigned short product_id, const unsigned short interface_id) {
   struct udev *           udev;
   struct udev_enumerate * enumerate;
@@ -143,6 +214,7 @@ struct ft260_dev *ft260_i2c_create(const char *devpath) {
   char *   hidpath = (char *)devpath;
   uint8_t  buf[26];
   uint16_t freq;
+  struct ft260_system_status sys;
 
   if (!hidpath) {
     if (!(hidpath = ft260_get_hidpath(0x0403, 0x6030, 0))) {
@@ -191,7 +263,7 @@ struct ft260_dev *ft260_i2c_create(const char *devpath) {
 
   // Read the System Status
   memset(buf, 0, sizeof(buf));
-  buf[0] = 0xA1; // SYSTEM_STATUS_ID
+  buf[0] = FT260_SYSTEM_SETTING_ID; // SYSTEM_STATUS
   if (!ft260_feature_io(d, INPUT, buf, 26)) {
     LOG(LL_ERROR, ("Could not read FT260 system status"));
     close(d->fd);
@@ -199,6 +271,10 @@ struct ft260_dev *ft260_i2c_create(const char *devpath) {
     return NULL;
   }
   LOG_HEXDUMP(LL_DEBUG, "Status", buf, 26);
+  ft260_decode_system_status(d, buf, &sys);
+  LOG(LL_DEBUG, ("System status: chip_mode=%u clock=%s suspended=%d pwren=%d i2c=%d uart_mode=%u power_saving=%d",
+                 sys.chip_mode, ft260_clock_str(sys.clock), sys.suspended, sys.pwren,
+                 sys.i2c_enable, sys.uart_mode, sys.power_saving));
 
   // Reset I2C
   if (!ft260_i2c_reset(d)) {
@@ -209,8 +285,8 @@ struct ft260_dev *ft260_i2c_create(const char *devpath) {
   }
 
   // Set the chip to I2C mode
-  buf[0] = 0xA1; // SYSTEM_SETTING_ID
-  buf[1] = 0x02; // I2C_MODE
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_I2C_MODE;
   buf[2] = 1;    // Enable
   if (!ft260_feature_io(d, OUTPUT, buf, 3)) {
     LOG(LL_ERROR, ("Could not set mode to I2C"));
@@ -226,7 +302,9 @@ struct ft260_dev *ft260_i2c_create(const char *devpath) {
     return NULL;
   }
 
-  LOG(LL_DEBUG, ("FT260 initialized: devpath=%s fd=%d bustype=%s vendor=0x%04x product=0x%04x rawname='%s' i2cfreq=%ukHz", d->devpath, d->fd, ft260_bus_type_str(d->info.bustype), d->info.vendor, d->info.product, d->rawname, freq));
+  LOG(LL_DEBUG, ("FT260 initialized: devpath=%s fd=%d bustype=%s vendor=0x%04x product=0x%04x rawname='%s' i2cfreq=%ukHz clock=%s power_saving=%s",
+                 d->devpath, d->fd, ft260_bus_type_str(d->info.bustype), d->info.vendor, d->info.product, d->rawname, freq,
+                 ft260_clock_str(d->clock), d->power_saving ? "on" : "off"));
 
   return d;
 }
@@ -236,6 +314,7 @@ bool ft260_i2c_destroy(struct ft260_dev **d) {
     return false;
   }
   if ((*d)->fd != -1) {
+    ft260_i2c_flush(*d);
     close((*d)->fd);
   }
   if ((*d)->devpath) {
@@ -263,6 +342,197 @@ bool ft260_i2c_get_status(struct ft260_dev *d, uint8_t *status) {
   return true;
 }
 
+bool ft260_get_system_status(struct ft260_dev *d, struct ft260_system_status *status) {
+  uint8_t buf[26];
+
+  memset(buf, 0, sizeof(buf));
+  buf[0] = FT260_SYSTEM_SETTING_ID; // SYSTEM_STATUS
+  if (!ft260_feature_io(d, INPUT, buf, sizeof(buf))) {
+    return false;
+  }
+  ft260_decode_system_status(d, buf, status);
+  return true;
+}
+
+bool ft260_set_clock(struct ft260_dev *d, const enum ft260_clock clock) {
+  uint8_t buf[3];
+
+  if (clock > FT260_CLOCK_48MHZ) {
+    return false;
+  }
+  if (!ft260_i2c_flush(d)) {
+    return false;
+  }
+  memset(buf, 0, sizeof(buf));
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_CLOCK;
+  buf[2] = (uint8_t)clock;
+
+  if (!ft260_feature_io(d, OUTPUT, buf, sizeof(buf))) {
+    return false;
+  }
+  if (!ft260_get_system_status(d, NULL)) {
+    return false;
+  }
+
+  return clock == d->clock;
+}
+
+bool ft260_get_clock(struct ft260_dev *d, enum ft260_clock *clock) {
+  if (!ft260_get_system_status(d, NULL)) {
+    return false;
+  }
+  if (clock) {
+    *clock = d->clock;
+  }
+  return true;
+}
+
+bool ft260_set_power_saving(struct ft260_dev *d, const bool enable) {
+  uint8_t buf[3];
+
+  if (!ft260_i2c_flush(d)) {
+    return false;
+  }
+  memset(buf, 0, sizeof(buf));
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_POWER_SAVING;
+  buf[2] = enable ? 1 : 0;
+
+  if (!ft260_feature_io(d, OUTPUT, buf, sizeof(buf))) {
+    return false;
+  }
+  if (!ft260_get_system_status(d, NULL)) {
+    return false;
+  }
+
+  return enable == d->power_saving;
+}
+
+bool ft260_get_power_saving(struct ft260_dev *d, bool *enable) {
+  if (!ft260_get_system_status(d, NULL)) {
+    return false;
+  }
+  if (enable) {
+    *enable = d->power_saving;
+  }
+  return true;
+}
+
+bool ft260_int_enable(struct ft260_dev *d, enum ft260_int_trigger trigger, uint8_t duration, ft260_int_cb cb, void *arg) {
+  uint8_t buf[4];
+
+  if (!d || !cb || trigger > FT260_INT_LEVEL_LOW || duration < 1 || duration > 3) {
+    return false;
+  }
+  if (!ft260_i2c_flush(d)) {
+    return false;
+  }
+
+  memset(buf, 0, sizeof(buf));
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_INT_TRIGGER;
+  buf[2] = (uint8_t)trigger;
+  buf[3] = duration;
+  if (!ft260_feature_io(d, OUTPUT, buf, 4)) {
+    LOG(LL_ERROR, ("Could not set interrupt trigger"));
+    return false;
+  }
+
+  buf[1] = FT260_SYSTEM_SET_INTERRUPT;
+  buf[2] = 1; // Enable
+  if (!ft260_feature_io(d, OUTPUT, buf, 3)) {
+    LOG(LL_ERROR, ("Could not enable interrupt"));
+    return false;
+  }
+
+  d->int_cb      = cb;
+  d->int_arg     = arg;
+  d->int_pending = 0;
+  return true;
+}
+
+bool ft260_int_disable(struct ft260_dev *d) {
+  uint8_t buf[3];
+
+  if (!d) {
+    return false;
+  }
+  d->int_cb      = NULL;
+  d->int_arg     = NULL;
+  d->int_pending = 0;
+
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_INTERRUPT;
+  buf[2] = 0; // Disable
+  return ft260_feature_io(d, OUTPUT, buf, sizeof(buf));
+}
+
+// Read every input report queued on the fd. Interrupt reports are counted,
+// anything else is stale I2C data and is dropped.
+static bool ft260_drain_input(struct ft260_dev *d) {
+  uint8_t buf[64];
+  ssize_t res;
+
+  while ((res = read(d->fd, buf, sizeof(buf))) != 0) {
+    if (res < 0) {
+      if (errno == EAGAIN) {
+        break;
+      }
+      LOG(LL_ERROR, ("read error: %s", strerror(errno)));
+      return false;
+    }
+    if (res >= 2 && buf[0] == FT260_INT_STATUS_ID && (buf[1] & FT260_INT_STATUS_INTRIN)) {
+      d->int_pending++;
+    } else {
+      LOG(LL_DEBUG, ("Ignoring input report 0x%02x", buf[0]));
+    }
+  }
+  return true;
+}
+
+// Run the callback for every pending interrupt, including ones that arrive
+// while the callback itself is reading from the bus.
+static int ft260_int_dispatch(struct ft260_dev *d) {
+  int count = 0;
+
+  while (d->int_pending > 0 && d->int_cb) {
+    d->int_pending--;
+    d->int_cb(d, d->int_arg);
+    count++;
+  }
+  return count;
+}
+
+int ft260_int_poll(struct ft260_dev *d, int timeout_ms) {
+  ssize_t       res;
+  struct pollfd pfd;
+
+  if (!d || d->fd < 0 || !d->int_cb) {
+    return -1;
+  }
+  // Buffered configuration writes may be what makes the slave raise INTRIN.
+  if (!ft260_i2c_flush(d)) {
+    return -1;
+  }
+  if (d->int_pending > 0) {
+    return ft260_int_dispatch(d);
+  }
+
+  pfd.fd     = d->fd;
+  pfd.events = POLLIN;
+  res        = poll(&pfd, 1, timeout_ms);
+  if (res < 0) {
+    LOG(LL_ERROR, ("poll error: %s", strerror(errno)));
+    return -1;
+  }
+
+  if (res > 0 && !ft260_drain_input(d)) {
+    return -1;
+  }
+  return ft260_int_dispatch(d);
+}
+
 bool ft260_i2c_get_speed(struct ft260_dev *d, uint16_t *freq_khz) {
   uint8_t status = 0;
 
@@ -278,9 +548,12 @@ bool ft260_i2c_get_speed(struct ft260_dev *d, uint16_t *freq_khz) {
 bool ft260_i2c_set_speed(struct ft260_dev *d, const uint16_t freq_khz) {
   uint8_t buf[4];
 
+  if (!ft260_i2c_flush(d)) {
+    return false;
+  }
   memset(buf, 0, sizeof(buf));
-  buf[0] = 0xA1;            // SYSTEM_SETTING_ID
-  buf[1] = 0x22;            // I2C_SPEED
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_I2C_SPEED;
   buf[2] = freq_khz >> 8;   // MSB
   buf[3] = freq_khz & 0xff; // LSB
 
@@ -297,16 +570,21 @@ bool ft260_i2c_set_speed(struct ft260_dev *d, const uint16_t freq_khz) {
 bool ft260_i2c_reset(struct ft260_dev *d) {
   uint8_t buf[2];
 
+  // Best effort: a reset is often the recovery from a failed write.
+  ft260_i2c_flush(d);
   memset(buf, 0, sizeof(buf));
-  buf[0] = 0xA1;            /* SYSTEM_SETTING_ID */
-  buf[1] = 0x20;            /* RESET_I2C */
+  buf[0] = FT260_SYSTEM_SETTING_ID;
+  buf[1] = FT260_SYSTEM_SET_I2C_RESET;
   return ft260_feature_io(d, OUTPUT, buf, sizeof(buf));
 }
 
 bool ft260_i2c_read(struct ft260_dev *d, uint16_t addr, void *data, size_t len, bool stop) {
-  uint8_t buf[64];
-  int     res;
-  uint8_t status;
+  uint8_t       buf[64];
+  ssize_t       res;
+  uint8_t       status;
+  size_t        got   = 0;
+  int           waits = 0;
+  struct pollfd pfd;
 
   if (!d || d->fd == -1) {
     return false;
@@ -315,62 +593,103 @@ bool ft260_i2c_read(struct ft260_dev *d, uint16_t addr, void *data, size_t len,
   if (!data && len > 0) {
     return false;
   }
+  if (len > FT260_I2C_READ_MAX) {
+    LOG(LL_ERROR, ("Reading more than %d bytes at once is not supported", FT260_I2C_READ_MAX));
+    return false;
+  }
+  if (!ft260_i2c_flush(d)) {
+    return false;
+  }
 
   // Read from device
   buf[0] = 0xC2; // I2C read
   buf[1] = (uint8_t)addr;
   buf[2] = 0;
   if (addr == (uint16_t)-1) {
-    buf[1] = 0;
+    buf[1] = d->i2c_addr; // Continuation of the current transaction
   } else {
-    buf[2] |= 0x02;
+    d->i2c_addr = (uint8_t)addr;
+    buf[2]     |= 0x02;
   }
   if (stop) {
     buf[2] |= 0x04;
   }
-  len   &= 0xffff;
-  buf[3] = len >> 8;
-  buf[4] = len & 0xff;
+  buf[3] = len & 0xff; // LSB
+  buf[4] = len >> 8;   // MSB
 
-  printf("Write: ");
-  for (int i = 0; i < 5; i++) {
-    printf("0x%02x ", buf[i]);
+  // Wait for the controller to be ready
+  if (!ft260_i2c_wait(d)) {
+    LOG(LL_ERROR, ("Timeout waiting before read"));
+    return false;
+  }
+  // Data left over from an earlier read that failed must not be taken as ours.
+  if (!ft260_drain_input(d)) {
+    return false;
   }
-  printf("\r\n");
 
   res = write(d->fd, buf, 5);
-  if (res < 0) {
-    LOG(LL_ERROR, ("write error: %s", strerror(errno)));
-  } else {
-    LOG(LL_INFO, ("write %d bytes", res));
+  LOG(LL_DEBUG, ("Read request for %zu bytes from 0x%02x %sstart %sstop: %s", len, buf[1], buf[2] & 0x02 ? "" : "!", buf[2] & 0x04 ? "" : "!", (res == 5) ? "OK" : "FAIL"));
+  if (res != 5) {
+    return false;
   }
 
-  res = read(d->fd, buf, 64);
-  if (res < 0) {
-    LOG(LL_ERROR, ("read error: %s", strerror(errno)));
-  } else {
-    LOG(LL_INFO, ("read %d bytes", res));
-    for (int i = 0; i < res; i++) {
-      printf("0x%02x ", buf[i]);
+  // Data arrives in input reports 0xD0..0xDE: report ID, length, payload.
+  while (got < len) {
+    pfd.fd     = d->fd;
+    pfd.events = POLLIN;
+    res        = poll(&pfd, 1, FT260_I2C_POLL_MS);
+    if (res < 0) {
+      LOG(LL_ERROR, ("poll error: %s", strerror(errno)));
+      return false;
     }
-    printf("\r\n");
+    if (res == 0) {
+      // Nothing yet: bail out early if the controller gave up on the slave.
+      if (!ft260_i2c_get_status(d, &status)) {
+        return false;
+      }
+      if ((!(status & FT260_STATUS_MASTER_BUSY) && (status & FT260_STATUS_ERROR)) ||
+          ++waits * FT260_I2C_POLL_MS >= FT260_I2C_READ_TIMEOUT_MS) {
+        LOG(LL_ERROR, ("Read from 0x%02x failed after %zu of %zu bytes (status 0x%02x)", (uint8_t)addr, got, len, status));
+        return false;
+      }
+      continue;
+    }
+    res = read(d->fd, buf, sizeof(buf));
+    if (res < 0) {
+      if (errno == EAGAIN) {
+        continue;
+      }
+      LOG(LL_ERROR, ("read error: %s", strerror(errno)));
+      return false;
+    }
+    if (res >= 2 && buf[0] == FT260_INT_STATUS_ID) {
+      if (buf[1] & FT260_INT_STATUS_INTRIN) {
+        d->int_pending++;
+      }
+      continue;
+    }
+    if (res < 2 || buf[0] < 0xD0 || buf[0] > 0xDE) {
+      LOG(LL_DEBUG, ("Ignoring input report 0x%02x", res > 0 ? buf[0] : 0));
+      continue;
+    }
+    if (buf[1] > res - 2 || buf[1] > len - got) {
+      LOG(LL_ERROR, ("Malformed input report 0x%02x: %u bytes", buf[0], buf[1]));
+      return false;
+    }
+    memcpy((uint8_t *)data + got, buf + 2, buf[1]);
+    got += buf[1];
   }
 
-  ft260_i2c_get_status(d, &status);
-  LOG(LL_DEBUG, ("I2C Status: 0x%02x", status));
-  return false;
+  if (!ft260_i2c_wait(d)) {
+    LOG(LL_ERROR, ("Timeout waiting after read"));
+    return false;
+  }
+  return ft260_i2c_check_status(d, false);
 }
 
-/*
- * Write specified number of bytes to the specified address.
- * Address should not include the R/W bit. If addr is -1, START is not
- * performed.
- * If |stop| is true, then at the end of the operation bus will be released.
- */
-
-bool ft260_i2c_write(struct ft260_dev *d, uint16_t addr, const void *data, size_t len, bool stop) {
+// Send one write report. If `probe` is set, a NACK is an expected outcome.
+static bool ft260_i2c_write_report(struct ft260_dev *d, uint16_t addr, const void *data, size_t len, bool stop, bool probe) {
   uint8_t buf[64];
-  uint8_t status;
   ssize_t written = 0;
 
   if (!d || d->fd == -1) {
@@ -379,17 +698,21 @@ bool ft260_i2c_write(struct ft260_dev *d, uint16_t addr, const void *data, size_
   if (!data && len > 0) {
     return false;
   }
-  if (len > 60) {
-    LOG(LL_ERROR, ("Writing packets larger than 60 bytes is not (yet) supported"));
+  if (len > FT260_I2C_WRITE_MAX) {
+    LOG(LL_ERROR, ("Writing packets larger than %d bytes is not (yet) supported", FT260_I2C_WRITE_MAX));
+    return false;
+  }
+  if (!ft260_i2c_flush(d)) {
     return false;
   }
 
   buf[0] = 0xD0 + (len <= 4 ? 0 : (len - 1) / 4); // Report ID 0xD0=4 bytes, 0xD1=8 bytes, .. 0xDE=60 bytes.
-  buf[1] = 0;
+  buf[1] = d->i2c_addr;                           // Continuation of the current transaction
   buf[2] = 0x00;                                  // Flags; 2=|start|, 4=|stop|
   if (addr != (uint16_t)-1) {
-    buf[1]  = (uint8_t)addr;
-    buf[2] |= 0x02;          // Set start bit.
+    d->i2c_addr = (uint8_t)addr;
+    buf[1]      = (uint8_t)addr;
+    buf[2]     |= 0x02;      // Set start bit.
   }
   if (stop) {
     buf[2] |= 0x04;          // Set stop bit.
@@ -414,24 +737,20 @@ bool ft260_i2c_write(struct ft260_dev *d, uint16_t addr, const void *data, size_
     return false;
   }
 
-  if (!ft260_i2c_get_status(d, &status)) {
-    return false;
-  }
-  LOG(LL_INFO, ("Status: 0x%02x", status));
+  return ft260_i2c_check_status(d, probe);
+}
 
-  if (status & FT260_STATUS_MASTER_BUSY) {
-    LOG(LL_ERROR, ("Error: controller busy"));
-    return false;
-  }
-  if (status & FT260_STATUS_ERROR) {
-    LOG(LL_ERROR, ("Error: Error condition: %s %s %s",
-                   (status & FT260_STATUS_ERROR_SLAVE_ACK ? "(slave_ack)" : ""),
-                   (status & FT260_STATUS_ERROR_DATA_ACK ? "(data_ack)" : ""),
-                   (status & FT260_STATUS_ERROR_LOST ? "(lost)" : "")));
-    return false;
-  }
-  if (status & FT260_STATUS_BUS_BUSY) {
-    LOG(LL_DEBUG, ("Status: I2C Bus Busy"));
-  }
-  return true;
+/*
+ * Write specified number of bytes to the specified address.
+ * Address should not include the R/W bit. If addr is -1, START is not
+ * performed.
+ * If |stop| is true, then at the end of the operation bus will be released.
+ */
+
+bool ft260_i2c_write(struct ft260_dev *d, uint16_t addr, const void *data, size_t len, bool stop) {
+  return ft260_i2c_write_report(d, addr, data, len, stop, false /* probe */);
+}
+
+bool ft260_i2c_probe(struct ft260_dev *d, uint16_t addr) {
+  return ft260_i2c_write_report(d, addr, NULL, 0, true /* stop */, true /* probe */);
 }